@@ -14,7 +14,11 @@ CREATE TABLE IF NOT EXISTS `farm_telemetry.soil_readings` (
   moisture_raw INT64 OPTIONS(description="Raw ADC value (0-1024)"),
   moisture_pct INT64 OPTIONS(description="Calculated percentage (0-100)"),
   battery_volts FLOAT64 OPTIONS(description="Battery voltage level"),
-  meta_data STRING OPTIONS(description="Debug info (e.g., transmission method)")
+  meta_data STRING OPTIONS(description="Debug info (e.g., transmission method)"),
+  phase_trace STRING OPTIONS(description="Hex FarmTrace frames (Hub + Spoke phase timings)")
 )
 PARTITION BY DATE(event_ts); 
 -- Partitioning by day reduces query costs significantly for IoT data
+
+-- 3. Migration (existing tables created before phase tracing)
+-- ALTER TABLE `farm_telemetry.soil_readings` ADD COLUMN IF NOT EXISTS phase_trace STRING;
@@ -1,6 +1,8 @@
 import functions_framework
 from datetime import datetime
 import os
+import threading
+import time
 from flask import jsonify
 from google.cloud import storage
 from google.cloud import bigquery
@@ -11,8 +13,170 @@ from google.cloud import bigquery
 BQ_TABLE_ID = "farm-hub-482111.farm_telemetry.soil_readings"
 
 # 2. GCS Config
-BUCKET_NAME = "farm-images-archive" 
-EXPECTED_API_KEY = "FARM_SEC" 
+BUCKET_NAME = "farm-images-archive"
+EXPECTED_API_KEY = "FARM_SEC"
+
+# 3. Micro-Batch Config (Telemetry -> BigQuery)
+# Rows are flushed when either limit is hit, whichever comes first.
+BATCH_MAX_ROWS = int(os.environ.get("BATCH_MAX_ROWS", 50))
+BATCH_MAX_AGE_S = float(os.environ.get("BATCH_MAX_AGE_S", 0.25))
+# Backpressure: beyond this many queued rows, new telemetry gets a 503.
+BATCH_QUEUE_LIMIT = int(os.environ.get("BATCH_QUEUE_LIMIT", 1000))
+# How long a request waits for its row's flush before giving up (504).
+BATCH_WAIT_TIMEOUT_S = float(os.environ.get("BATCH_WAIT_TIMEOUT_S", 10))
+
+# --- SHARED CLIENTS ---
+# Created once per instance and reused across requests. Building a client
+# per request re-does auth and connection setup, which dominates latency
+# when a fleet of hubs uploads in bursts.
+_client_lock = threading.Lock()
+_bq_client = None
+_storage_client = None
+_bucket = None
+
+def get_bq_client():
+    global _bq_client
+    if _bq_client is None:
+        with _client_lock:
+            if _bq_client is None:
+                _bq_client = bigquery.Client()
+    return _bq_client
+
+def get_bucket():
+    global _storage_client, _bucket
+    if _bucket is None:
+        with _client_lock:
+            if _bucket is None:
+                _storage_client = storage.Client()
+                _bucket = _storage_client.bucket(BUCKET_NAME)
+    return _bucket
+
+
+class PendingRow:
+    """
+    One queued telemetry row. The request thread waits on `done` until the
+    batch containing this row has been flushed, then reads `error`.
+    """
+    __slots__ = ("row", "done", "error")
+
+    def __init__(self, row):
+        self.row = row
+        self.done = threading.Event()
+        self.error = None
+
+    def wait(self, timeout):
+        return self.done.wait(timeout)
+
+
+class TelemetryBatcher:
+    """
+    In-process micro-batcher for BigQuery streaming inserts.
+    - Flushes by row count (max_rows) or by age of the oldest row (max_age_s).
+    - Rejects new rows once queue_limit is reached (backpressure).
+    - Maps BigQuery's per-row insert errors back to the originating request.
+    """
+
+    def __init__(self, table_id, max_rows, max_age_s, queue_limit, client_factory):
+        self.table_id = table_id
+        self.max_rows = max_rows
+        self.max_age_s = max_age_s
+        self.queue_limit = queue_limit
+        self.client_factory = client_factory
+
+        self._cond = threading.Condition()
+        self._queue = []
+        self._oldest = 0.0
+        self._thread = None
+        self._pid = None
+
+    def submit(self, row):
+        """Queues a row. Returns a PendingRow, or None if the queue is full."""
+        with self._cond:
+            if len(self._queue) >= self.queue_limit:
+                return None
+            self._ensure_worker()
+            pending = PendingRow(row)
+            if not self._queue:
+                self._oldest = time.monotonic()
+            self._queue.append(pending)
+            self._cond.notify()
+            return pending
+
+    def cancel(self, pending):
+        """
+        Withdraws a row that has not been picked up for a flush yet, so a
+        request that gave up (504) never lands in the table. Returns False if
+        the row is already part of an in-flight insert.
+        """
+        with self._cond:
+            try:
+                self._queue.remove(pending)
+            except ValueError:
+                return False
+            if not self._queue:
+                self._oldest = 0.0
+            return True
+
+    def _ensure_worker(self):
+        # Started lazily (and restarted after fork) so gunicorn workers each
+        # get their own flusher thread.
+        if self._thread is None or self._pid != os.getpid() or not self._thread.is_alive():
+            self._pid = os.getpid()
+            self._thread = threading.Thread(target=self._run, name="bq-batcher", daemon=True)
+            self._thread.start()
+
+    def _take_batch(self):
+        with self._cond:
+            while True:
+                if not self._queue:
+                    self._cond.wait()
+                    continue
+                if len(self._queue) >= self.max_rows:
+                    break
+                remaining = self.max_age_s - (time.monotonic() - self._oldest)
+                if remaining <= 0:
+                    break
+                self._cond.wait(remaining)
+
+            batch = self._queue[:self.max_rows]
+            del self._queue[:self.max_rows]
+            if self._queue:
+                # Leftovers have been waiting at least as long as this batch.
+                self._oldest = time.monotonic() - self.max_age_s
+            return batch
+
+    def _run(self):
+        while True:
+            self._flush(self._take_batch())
+
+    def _flush(self, batch):
+        try:
+            # skip_invalid_rows: without it one bad row fails the whole batch
+            # and every other row comes back as "stopped".
+            errors = self.client_factory().insert_rows_json(
+                self.table_id, [p.row for p in batch], skip_invalid_rows=True
+            )
+            for err in errors or []:
+                idx = err.get("index")
+                if idx is not None and 0 <= idx < len(batch):
+                    batch[idx].error = err.get("errors") or "insert failed"
+            failed = sum(1 for p in batch if p.error is not None)
+            if failed:
+                print(f"!! BQ INSERT ERROR: {failed}/{len(batch)} rows rejected: {errors}")
+            else:
+                print(f">> SUCCESS: {len(batch)} telemetry rows inserted into BigQuery.")
+        except Exception as e:
+            print(f"!! BQ FLUSH EXCEPTION ({len(batch)} rows): {e}")
+            for p in batch:
+                p.error = str(e)
+        finally:
+            for p in batch:
+                p.done.set()
+
+
+telemetry_batcher = TelemetryBatcher(
+    BQ_TABLE_ID, BATCH_MAX_ROWS, BATCH_MAX_AGE_S, BATCH_QUEUE_LIMIT, get_bq_client
+)
 
 @functions_framework.http
 def ingest_data(request):
@@ -21,10 +185,10 @@ def ingest_data(request):
     - GET: Handles Sensor Telemetry
     - POST: Handles Image Uploads
     """
-    
+
     # 1. SECURITY: Check Token
     token = request.args.get('token') or request.headers.get('X-Api-Key')
-    
+
     if token != EXPECTED_API_KEY:
         print(f"!! Unauthorized Access Attempt. Token: {token}")
         return jsonify({"error": "Unauthorized"}), 401
@@ -39,7 +203,7 @@ def ingest_data(request):
 
 def handle_telemetry(request):
     """
-    Logs sensor data and inserts into BigQuery using your Schema.
+    Queues sensor data for a batched BigQuery insert and waits for the result.
     """
     try:
         # 1. Extract params from URL
@@ -47,40 +211,68 @@ def handle_telemetry(request):
         raw = request.args.get('raw')
         pct = request.args.get('pct')
         bat = request.args.get('bat')
-        
-        # --- FIX IS HERE ---
-        # Use datetime.now() directly because of 'from datetime import datetime'
+        trace = request.args.get('trace')  # Hex FarmTrace frames (optional)
+
         event_ts = datetime.utcnow().isoformat()
 
-        print(f"TELEMETRY: Device={device_id}, Soil={pct}%, Bat={bat}V")
-
-        # 3. Insert into BigQuery
-        client = bigquery.Client()
-        
-        rows_to_insert = [
-            {
-                "event_ts": event_ts,
-                "device_id": str(device_id),
-                "moisture_raw": int(raw) if raw else 0,
-                "moisture_pct": int(pct) if pct else 0,
-                "battery_volts": float(bat) if bat else 0.0,
-                "meta_data": "Ingested via Cloud Run Proxy" 
-            }
-        ]
-
-        errors = client.insert_rows_json(BQ_TABLE_ID, rows_to_insert)
-
-        if errors == []:
-            print(">> SUCCESS: Telemetry inserted into BigQuery.")
-            return jsonify({"status": "success", "type": "telemetry"}), 200
-        else:
-            print(f"!! BQ INSERT ERROR: {errors}")
-            return jsonify({"error": str(errors)}), 500
+        print(f"TELEMETRY: Device={device_id}, Raw={raw}, Soil={pct}%, Bat={bat}V")
+
+        # 2. Build the row (raw stays NULL if the sender didn't report it)
+        row = {
+            "event_ts": event_ts,
+            "device_id": str(device_id),
+            "moisture_raw": int(raw) if raw else None,
+            "moisture_pct": int(pct) if pct else 0,
+            "battery_volts": float(bat) if bat else 0.0,
+            "meta_data": "Ingested via Cloud Run Proxy"
+        }
+        # Only sent when present, so tables without the column keep working
+        if trace:
+            row["phase_trace"] = trace
+
+        # 3. Hand off to the batcher
+        pending = telemetry_batcher.submit(row)
+        if pending is None:
+            print("!! BATCH QUEUE FULL: Rejecting telemetry.")
+            return jsonify({"error": "Ingest queue full, retry later"}), 503, {"Retry-After": "5"}
+
+        if not pending.wait(BATCH_WAIT_TIMEOUT_S):
+            if telemetry_batcher.cancel(pending):
+                print("!! BATCH TIMEOUT: Row withdrawn before flush.")
+                return jsonify({"error": "Timed out waiting for BigQuery flush"}), 504
+            # Already being inserted: report what actually happened to it
+            if not pending.wait(BATCH_WAIT_TIMEOUT_S):
+                print("!! BATCH TIMEOUT: Insert still in flight, outcome unknown.")
+                return jsonify({"error": "BigQuery insert still in flight, outcome unknown"}), 504
+
+        if pending.error is not None:
+            return jsonify({"error": str(pending.error)}), 500
+
+        return jsonify({"status": "success", "type": "telemetry"}), 200
 
     except Exception as e:
         print(f"Telemetry Exception: {e}")
         return jsonify({"error": str(e)}), 500
-        
+
+def queue_trace_row(device_id, trace):
+    """
+    Stores a phase trace that arrived without telemetry (image uploads) as a
+    trace-only row, so trace_report.py sees it in the same `phase_trace`
+    export. Not waited on: the image is already stored, and a lost trace
+    only costs diagnostics (flush errors are logged by the batcher).
+    """
+    row = {
+        "event_ts": datetime.utcnow().isoformat(),
+        "device_id": str(device_id),
+        "moisture_raw": None,
+        "moisture_pct": None,
+        "battery_volts": None,
+        "meta_data": "Phase trace from image upload",
+        "phase_trace": trace,
+    }
+    if telemetry_batcher.submit(row) is None:
+        print("!! BATCH QUEUE FULL: Dropping image phase trace.")
+
 def handle_image_upload(request):
     """
     Streams image file to GCS with organized folders: uploads/YYYY/MM/DD/HH-MM-SS.jpg
@@ -91,28 +283,31 @@ def handle_image_upload(request):
             return jsonify({"error": "No image file provided"}), 400
 
         file = request.files['image']
-        
+
         # 1. Get current UTC time
         now = datetime.utcnow()
-        
+
         # 2. Build the folder path: uploads/2026/01/03
         folder_path = f"uploads/{now.year}/{now.month:02d}/{now.day:02d}"
-        
+
         # 3. Build the filename: 18-30-05.jpg (ignores original 'pic' name)
         file_name = f"{now.strftime('%H-%M-%S')}.jpg"
-        
+
         # 4. Combine them
         destination_blob_name = f"{folder_path}/{file_name}"
 
-        storage_client = storage.Client()
-        bucket = storage_client.bucket(BUCKET_NAME)
-        blob = bucket.blob(destination_blob_name)
-        
+        blob = get_bucket().blob(destination_blob_name)
+
         # 5. Upload (Force JPEG content type since we know it's a camera stream)
         blob.upload_from_file(file, content_type='image/jpeg')
 
         print(f"IMAGE UPLOADED: gs://{BUCKET_NAME}/{destination_blob_name}")
-        
+
+        # 6. Hub/Camera phase trace goes to BigQuery with the telemetry traces
+        trace = request.args.get('trace')
+        if trace:
+            queue_trace_row(request.args.get('device_id') or "spoke_2", trace)
+
         # Return the new path so you can debug/verify
         return jsonify({"status": "success", "gcs_path": destination_blob_name}), 200
 
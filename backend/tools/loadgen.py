@@ -0,0 +1,331 @@
+"""
+FarmHub Ingest Load Generator
+
+Replays hub traffic (telemetry GETs + camera POSTs) against the ingest
+function in-process, with BigQuery and GCS replaced by local stand-ins that
+simulate network latency. Reports requests/s and p50/p99 latency per route.
+
+Usage:
+    python backend/tools/loadgen.py --hubs 50 --cycles 20 --concurrency 64
+    python backend/tools/loadgen.py --hubs 50 --cycles 20 --baseline   # pre-batching code path
+
+--baseline replays the old handlers: a new BigQuery / Storage client per
+request (each costing --client-init-ms) and one insert_rows_json per row,
+made from the request thread. Without it, main.py builds its shared clients
+through the same stand-in factories, so client reuse is measured too.
+
+Runs without the GCP / Flask packages installed: missing modules are shimmed.
+
+--concurrency models one instance's request concurrency (deploy flag
+--concurrency). Use --concurrency 1 --batch-rows 1 to model the Gen 2
+default of one request per instance.
+"""
+
+import argparse
+import contextlib
+import io
+import os
+import random
+import statistics
+import sys
+import threading
+import time
+import types
+from datetime import datetime
+from concurrent.futures import ThreadPoolExecutor
+
+FUNCTION_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "function_ingest-farm-data")
+
+
+# --- DEPENDENCY SHIMS ---
+def install_shims():
+    """Stubs out deploy-only modules so main.py imports on a bare Python."""
+    try:
+        import functions_framework  # noqa: F401
+    except ImportError:
+        ff = types.ModuleType("functions_framework")
+        ff.http = lambda fn: fn
+        sys.modules["functions_framework"] = ff
+
+    try:
+        import flask  # noqa: F401
+    except ImportError:
+        fl = types.ModuleType("flask")
+        fl.jsonify = lambda obj: obj
+        sys.modules["flask"] = fl
+
+    try:
+        from google.cloud import bigquery, storage  # noqa: F401
+    except ImportError:
+        google = sys.modules.setdefault("google", types.ModuleType("google"))
+        cloud = types.ModuleType("google.cloud")
+        bq = types.ModuleType("google.cloud.bigquery")
+        gcs = types.ModuleType("google.cloud.storage")
+        bq.Client = gcs.Client = lambda: None
+        cloud.bigquery, cloud.storage = bq, gcs
+        google.cloud = cloud
+        sys.modules.update({
+            "google.cloud": cloud,
+            "google.cloud.bigquery": bq,
+            "google.cloud.storage": gcs,
+        })
+
+
+# --- LOCAL STAND-INS ---
+class FakeBigQuery:
+    """insert_rows_json with a fixed round-trip cost plus a small per-row cost."""
+
+    def __init__(self, init_s, rtt_s, per_row_s, reject_rate):
+        self.init_s = init_s
+        self.rtt_s = rtt_s
+        self.per_row_s = per_row_s
+        self.reject_rate = reject_rate
+        self.calls = 0
+        self.rows = 0       # Rows accepted
+        self.submitted = 0  # Rows sent, accepted or not
+        self.clients = 0
+        self._lock = threading.Lock()
+
+    def Client(self):
+        """Stands in for bigquery.Client(): pays auth/connection setup once per client."""
+        time.sleep(self.init_s)
+        with self._lock:
+            self.clients += 1
+        return self
+
+    def insert_rows_json(self, table_id, rows, skip_invalid_rows=False):
+        """
+        Mirrors insertAll semantics: by default one invalid row fails the whole
+        request and the valid rows are reported as "stopped".
+        """
+        time.sleep(self.rtt_s + self.per_row_s * len(rows))
+        invalid = [i for i in range(len(rows)) if random.random() < self.reject_rate]
+        inserted = len(rows) - len(invalid) if (skip_invalid_rows or not invalid) else 0
+        with self._lock:
+            self.calls += 1
+            self.submitted += len(rows)
+            self.rows += inserted
+        errors = [{"index": i, "errors": [{"reason": "invalid", "message": "rejected by stand-in"}]}
+                  for i in invalid]
+        if invalid and not skip_invalid_rows:
+            bad = set(invalid)
+            errors += [{"index": i, "errors": [{"reason": "stopped", "message": ""}]}
+                       for i in range(len(rows)) if i not in bad]
+            errors.sort(key=lambda e: e["index"])
+        return errors
+
+
+class FakeBlob:
+    def __init__(self, bucket, name):
+        self.bucket = bucket
+        self.name = name
+
+    def upload_from_file(self, file, content_type=None):
+        data = file.read()
+        time.sleep(self.bucket.rtt_s + len(data) / self.bucket.bytes_per_s)
+        with self.bucket.lock:
+            self.bucket.objects[self.name] = len(data)
+            self.bucket.uploads += 1
+
+
+class FakeBucket:
+    def __init__(self, init_s, rtt_s, bytes_per_s):
+        self.init_s = init_s
+        self.rtt_s = rtt_s
+        self.bytes_per_s = bytes_per_s
+        self.objects = {}
+        self.uploads = 0
+        self.clients = 0
+        self.lock = threading.Lock()
+
+    def Client(self):
+        """Stands in for storage.Client()."""
+        time.sleep(self.init_s)
+        with self.lock:
+            self.clients += 1
+        return self
+
+    def bucket(self, name):
+        return self
+
+    def blob(self, name):
+        return FakeBlob(self, name)
+
+
+class FakeRequest:
+    """The subset of flask.Request that main.py touches."""
+
+    def __init__(self, method, args, files=None):
+        self.method = method
+        self.args = args
+        self.headers = {}
+        self.files = files or {}
+
+
+# --- BASELINE (pre-batching handlers) ---
+def install_baseline(ingest):
+    """
+    Swaps in the original request path: a client per request and a
+    synchronous single-row insert from the request thread.
+    """
+    jsonify = ingest.jsonify
+
+    def handle_telemetry(request):
+        try:
+            device_id = request.args.get('device_id')
+            raw = request.args.get('raw')
+            pct = request.args.get('pct')
+            bat = request.args.get('bat')
+            event_ts = datetime.utcnow().isoformat()
+
+            client = ingest.bigquery.Client()
+            rows_to_insert = [{
+                "event_ts": event_ts,
+                "device_id": str(device_id),
+                "moisture_raw": int(raw) if raw else None,
+                "moisture_pct": int(pct) if pct else 0,
+                "battery_volts": float(bat) if bat else 0.0,
+                "meta_data": "Ingested via Cloud Run Proxy",
+            }]
+            errors = client.insert_rows_json(ingest.BQ_TABLE_ID, rows_to_insert)
+            if errors == []:
+                return jsonify({"status": "success", "type": "telemetry"}), 200
+            return jsonify({"error": str(errors)}), 500
+        except Exception as e:
+            return jsonify({"error": str(e)}), 500
+
+    ingest.handle_telemetry = handle_telemetry
+    ingest.get_bucket = lambda: ingest.storage.Client().bucket(ingest.BUCKET_NAME)
+
+
+# --- TRAFFIC MODEL ---
+def build_cycle(hubs, image_every, cycle):
+    """
+    One wake window across the fleet. Each hub forwards spoke_1 soil telemetry
+    and, every `image_every` cycles, one camera frame from spoke_2.
+    """
+    reqs = []
+    for hub in range(hubs):
+        raw = random.randint(300, 700)
+        pct = max(0, min(100, (700 - raw) * 100 // 400))
+        reqs.append(("telemetry", {
+            "token": "FARM_SEC",
+            "device_id": f"hub{hub}_spoke_1",
+            "raw": str(raw),
+            "pct": str(pct),
+            "bat": f"{random.uniform(11.0, 12.6):.2f}",
+        }))
+        if image_every and cycle % image_every == 0:
+            reqs.append(("image", {"token": "FARM_SEC", "device_id": f"hub{hub}_spoke_2"}))
+    random.shuffle(reqs)
+    return reqs
+
+
+def percentile(values, pct):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    k = min(len(ordered) - 1, max(0, int(round(pct / 100.0 * (len(ordered) - 1)))))
+    return ordered[k]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--hubs", type=int, default=50, help="hubs in the fleet")
+    ap.add_argument("--cycles", type=int, default=10, help="wake windows to replay")
+    ap.add_argument("--concurrency", type=int, default=64, help="in-flight requests per instance (deploy --concurrency)")
+    ap.add_argument("--image-every", type=int, default=2, help="send an image every N cycles (0 = never)")
+    ap.add_argument("--image-bytes", type=int, default=30000, help="JPEG payload size")
+    ap.add_argument("--baseline", action="store_true", help="replay the pre-batching handlers")
+    ap.add_argument("--client-init-ms", type=float, default=100.0, help="stand-in cost of building a GCP client")
+    ap.add_argument("--bq-rtt-ms", type=float, default=80.0, help="stand-in insert round-trip")
+    ap.add_argument("--bq-row-us", type=float, default=50.0, help="stand-in per-row insert cost")
+    ap.add_argument("--bq-reject", type=float, default=0.0, help="fraction of rows the stand-in rejects")
+    ap.add_argument("--gcs-rtt-ms", type=float, default=60.0, help="stand-in upload round-trip")
+    ap.add_argument("--gcs-mbps", type=float, default=20.0, help="stand-in upload bandwidth (MB/s)")
+    ap.add_argument("--batch-rows", type=int, help="override BATCH_MAX_ROWS")
+    ap.add_argument("--batch-age", type=float, help="override BATCH_MAX_AGE_S")
+    ap.add_argument("--queue-limit", type=int, help="override BATCH_QUEUE_LIMIT")
+    ap.add_argument("--verbose", action="store_true", help="show the function's own log lines")
+    ap.add_argument("--seed", type=int, default=1)
+    opts = ap.parse_args()
+
+    random.seed(opts.seed)
+    install_shims()
+    sys.path.insert(0, os.path.abspath(FUNCTION_DIR))
+    import main as ingest
+
+    init_s = opts.client_init_ms / 1000.0
+    bq = FakeBigQuery(init_s, opts.bq_rtt_ms / 1000.0, opts.bq_row_us / 1e6, opts.bq_reject)
+    bucket = FakeBucket(init_s, opts.gcs_rtt_ms / 1000.0, opts.gcs_mbps * 1e6)
+    ingest.bigquery = types.SimpleNamespace(Client=bq.Client)
+    ingest.storage = types.SimpleNamespace(Client=bucket.Client)
+    if opts.baseline:
+        install_baseline(ingest)
+
+    batcher = ingest.telemetry_batcher
+    if opts.batch_rows is not None:
+        batcher.max_rows = max(1, opts.batch_rows)
+    if opts.batch_age is not None:
+        batcher.max_age_s = opts.batch_age
+    if opts.queue_limit is not None:
+        batcher.queue_limit = opts.queue_limit
+
+    try:
+        from flask import Flask
+        app_ctx = Flask("loadgen").app_context
+    except ImportError:
+        app_ctx = None
+
+    jpeg = b"\xff\xd8" + os.urandom(max(0, opts.image_bytes - 4)) + b"\xff\xd9"
+
+    def fire(item):
+        kind, args = item
+        files = {"image": io.BytesIO(jpeg)} if kind == "image" else None
+        req = FakeRequest("POST" if kind == "image" else "GET", args, files)
+        t0 = time.perf_counter()
+        if app_ctx:
+            with app_ctx():
+                resp = ingest.ingest_data(req)
+        else:
+            resp = ingest.ingest_data(req)
+        return kind, resp[1], time.perf_counter() - t0
+
+    results = []
+    t_start = time.perf_counter()
+    log_sink = contextlib.nullcontext() if opts.verbose else contextlib.redirect_stdout(io.StringIO())
+    with log_sink, ThreadPoolExecutor(max_workers=opts.concurrency) as pool:
+        for cycle in range(opts.cycles):
+            results.extend(pool.map(fire, build_cycle(opts.hubs, opts.image_every, cycle)))
+    elapsed = time.perf_counter() - t_start
+
+    # --- REPORT ---
+    print("\n=== FARMHUB INGEST LOAD TEST ===")
+    print(f"Hubs: {opts.hubs}  Cycles: {opts.cycles}  Concurrency: {opts.concurrency}")
+    if opts.baseline:
+        print(f"Mode: baseline (client per request, unbatched inserts), client init {opts.client_init_ms:.0f} ms")
+    else:
+        print(f"Batcher: max_rows={batcher.max_rows} max_age={batcher.max_age_s}s queue_limit={batcher.queue_limit}, "
+              f"client init {opts.client_init_ms:.0f} ms")
+    print(f"Total: {len(results)} requests in {elapsed:.2f}s -> {len(results) / elapsed:.1f} req/s\n")
+    print(f"{'route':<10} {'count':>6} {'req/s':>8} {'p50 ms':>8} {'p99 ms':>8}  status")
+    for kind in ("telemetry", "image"):
+        lat = [r[2] * 1000 for r in results if r[0] == kind]
+        if not lat:
+            continue
+        codes = {}
+        for r in results:
+            if r[0] == kind:
+                codes[r[1]] = codes.get(r[1], 0) + 1
+        code_str = " ".join(f"{c}x{n}" for c, n in sorted(codes.items()))
+        print(f"{kind:<10} {len(lat):>6} {len(lat) / elapsed:>8.1f} "
+              f"{statistics.median(lat):>8.1f} {percentile(lat, 99):>8.1f}  {code_str}")
+    if bq.calls:
+        print(f"\nBigQuery stand-in: {bq.submitted} rows in {bq.calls} inserts "
+              f"({bq.submitted / bq.calls:.1f} rows/insert), {bq.rows} accepted, {bq.clients} clients built")
+    print(f"GCS stand-in: {bucket.uploads} uploads -> {len(bucket.objects)} distinct objects, "
+          f"{bucket.clients} clients built")
+
+
+if __name__ == "__main__":
+    main()
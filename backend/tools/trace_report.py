@@ -0,0 +1,259 @@
+"""
+FarmHub Phase Trace Report
+
+Decodes FarmTrace frames (the `phase_trace` column / `trace` URL param) and
+prints per-phase latency histograms plus an estimated mAh per wake cycle.
+
+Input: a BigQuery CSV export with event_ts, device_id and phase_trace:
+    bq query --use_legacy_sql=false --format=csv --max_rows=100000 \\
+      'SELECT event_ts, device_id, phase_trace FROM farm_telemetry.soil_readings
+       WHERE phase_trace IS NOT NULL ORDER BY event_ts' > traces.csv
+    python backend/tools/trace_report.py traces.csv
+
+Image uploads are stored as trace-only rows (device_id of the camera Spoke,
+no telemetry), so camera and image-push phases come out of the same export.
+
+Cycles are reconstructed from upload order, so rows are sorted by event_ts
+and Spoke records are grouped per device_id and trace source (e.g.
+"spoke_2 / spoke_2"). Hub records are one stream whichever Spoke's upload
+carried them, so a Hub cycle that spans a telemetry and an image upload stays
+whole. Plain text with one hex trace per line also works, but then ordering
+is taken as given and all devices share one stream.
+
+Phases that ended in a failure or timeout (FARM_TRACE_FAILED) are listed
+as separate "<PHASE> FAIL" rows, so timeouts don't blur the success latency.
+
+Current draw figures are estimates; override them with --power my_power.json
+(same shape as DEFAULT_POWER below).
+"""
+
+import argparse
+import csv
+import json
+import re
+import statistics
+import struct
+import sys
+
+# --- FRAME FORMAT (mirror of common/FarmTrace/FarmTrace.h) ---
+FRAME_MAGIC = b"FT"
+FRAME_HDR = 4
+RECORD = struct.Struct("<BBHH")  # phase, cycle, start_cs, dur_ms
+PHASE_FAILED = 0x80              # Set on phases that ended in a failure/timeout
+
+PHASES = {
+    1: "AWAKE",
+    2: "RTC_ALIGN",
+    3: "SENSOR_WARMUP",
+    4: "ESPNOW_SEND",
+    5: "HUB_PING",
+    6: "CAM_INIT",
+    7: "CAM_WARMUP",
+    8: "CAM_CAPTURE",
+    9: "MODEM_SYNC",
+    10: "GPRS_ATTACH",
+    11: "HTTP_URL",
+    12: "HTTP_GET",
+    13: "HTTP_POST",
+    14: "SMS_SEND",
+}
+
+SOURCES = {0: "hub", 1: "spoke_1", 2: "spoke_2", 3: "spoke_3"}
+
+# --- POWER MODEL (mA) ---
+# base_ma: draw while awake (applied to AWAKE, or to every phase if the
+#          device has no AWAKE phase, like the always-on Hub).
+# phase_ma: extra draw on top of base_ma during a phase.
+# sleep_ma / period_s: deep sleep current and wake period, for the sleep share.
+DEFAULT_POWER = {
+    "hub": {
+        "base_ma": 110,
+        "phase_ma": {"MODEM_SYNC": 60, "GPRS_ATTACH": 180, "HTTP_URL": 120,
+                     "HTTP_GET": 250, "HTTP_POST": 350, "SMS_SEND": 220},
+        "sleep_ma": 0.0,
+        "period_s": 0,
+    },
+    "spoke_1": {
+        "base_ma": 75,
+        "phase_ma": {"SENSOR_WARMUP": 5, "ESPNOW_SEND": 95},
+        "sleep_ma": 0.02,
+        "period_s": 1800,
+    },
+    "spoke_2": {
+        "base_ma": 110,
+        "phase_ma": {"HUB_PING": 90, "CAM_INIT": 60, "CAM_WARMUP": 90,
+                     "CAM_CAPTURE": 110, "ESPNOW_SEND": 130},
+        "sleep_ma": 6.0,
+        "period_s": 900,
+    },
+}
+
+HIST_EDGES_MS = [10, 50, 100, 250, 500, 1000, 2000, 5000, 10000, 30000]
+HEX_FRAME = re.compile(r"(?:4654[0-9a-fA-F]{4,})")
+
+
+def decode_frames(blob):
+    """Yields (source_id, [records]) for each frame in a binary blob."""
+    pos = 0
+    while pos + FRAME_HDR <= len(blob):
+        if blob[pos:pos + 2] != FRAME_MAGIC:
+            break
+        src, count = blob[pos + 2], blob[pos + 3]
+        end = pos + FRAME_HDR + count * RECORD.size
+        if end > len(blob):
+            break
+        recs = [RECORD.unpack_from(blob, pos + FRAME_HDR + i * RECORD.size) for i in range(count)]
+        yield src, recs
+        pos = end
+
+
+def parse_rows(lines):
+    """Returns [(event_ts, device_id, trace_text)] sorted by event_ts when known."""
+    if lines and "phase_trace" in lines[0]:
+        rows = [(r.get("event_ts") or "", r.get("device_id") or "", r.get("phase_trace") or "")
+                for r in csv.DictReader(lines)]
+        rows.sort(key=lambda r: r[0])  # Stable; ISO/BQ timestamps sort lexically
+        return rows
+    return [("", "", line) for line in lines]
+
+
+def load_records(lines):
+    """
+    Returns {(device_id, source_name): [(phase, cycle, start_cs, dur_ms), ...]}
+    in upload order. device_id is "" for Hub records and plain-text input.
+    """
+    out = {}
+    for _, device, text in parse_rows(lines):
+        for token in HEX_FRAME.findall(text):
+            if len(token) % 2:
+                token = token[:-1]
+            for src, recs in decode_frames(bytes.fromhex(token)):
+                key = ("" if src == 0 else device, SOURCES.get(src, f"src_{src}"))
+                out.setdefault(key, []).extend(recs)
+    return out
+
+
+def phase_name(phase):
+    """Name for a raw phase byte; failed phases get their own " FAIL" row."""
+    base = phase & ~PHASE_FAILED
+    name = PHASES.get(base, f"P{base}")
+    return f"{name} FAIL" if phase & PHASE_FAILED else name
+
+
+def split_cycles(recs):
+    """Groups consecutive records that share a cycle number."""
+    cycles, current, last = [], [], None
+    for rec in recs:
+        if last is not None and rec[1] != last:
+            cycles.append(current)
+            current = []
+        current.append(rec)
+        last = rec[1]
+    if current:
+        cycles.append(current)
+    return cycles
+
+
+def cycle_mah(cycle, model):
+    has_awake = any(r[0] == 1 for r in cycle)
+    ma_ms = 0.0
+    for phase, _, _, dur in cycle:
+        # Failed phases draw like their successful counterpart
+        name = phase_name(phase & ~PHASE_FAILED)
+        if phase == 1:
+            ma_ms += model["base_ma"] * dur
+        else:
+            extra = model["phase_ma"].get(name, 0)
+            ma_ms += (extra if has_awake else model["base_ma"] + extra) * dur
+    return ma_ms / 3.6e6
+
+
+def percentile(values, pct):
+    ordered = sorted(values)
+    k = min(len(ordered) - 1, max(0, int(round(pct / 100.0 * (len(ordered) - 1)))))
+    return ordered[k]
+
+
+def histogram(durs, width=30):
+    buckets = [0] * (len(HIST_EDGES_MS) + 1)
+    for d in durs:
+        i = 0
+        while i < len(HIST_EDGES_MS) and d >= HIST_EDGES_MS[i]:
+            i += 1
+        buckets[i] += 1
+    peak = max(buckets) or 1
+    lines = []
+    for i, n in enumerate(buckets):
+        if n == 0:
+            continue
+        lo = 0 if i == 0 else HIST_EDGES_MS[i - 1]
+        label = f">={lo}" if i == len(HIST_EDGES_MS) else f"{lo}-{HIST_EDGES_MS[i]}"
+        lines.append(f"      {label:>11} ms | {'#' * max(1, n * width // peak):<{width}} {n}")
+    return lines
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("files", nargs="*", help="trace exports (default: stdin)")
+    ap.add_argument("--power", help="JSON file overriding DEFAULT_POWER entries")
+    ap.add_argument("--no-hist", action="store_true", help="summary table only")
+    opts = ap.parse_args()
+
+    power = json.loads(json.dumps(DEFAULT_POWER))
+    if opts.power:
+        with open(opts.power) as f:
+            for src, cfg in json.load(f).items():
+                power.setdefault(src, {"base_ma": 0, "phase_ma": {}, "sleep_ma": 0, "period_s": 0}).update(cfg)
+
+    lines = []
+    if opts.files:
+        for path in opts.files:
+            with open(path) as f:
+                lines.extend(f)
+    else:
+        lines = sys.stdin.readlines()
+
+    data = load_records(lines)
+    if not data:
+        print("No FarmTrace frames found.")
+        return 1
+
+    for device, src in sorted(data):
+        recs = data[(device, src)]
+        cycles = split_cycles(recs)
+        label = f"{device} / {src}" if device else src
+        print(f"\n=== {label.upper()}: {len(recs)} records, {len(cycles)} cycles ===")
+        print(f"  {'phase':<14} {'n':>5} {'p50 ms':>8} {'p90 ms':>8} {'p99 ms':>8} {'max ms':>8} {'share':>6}")
+
+        by_phase = {}
+        for phase, _, _, dur in recs:
+            by_phase.setdefault(phase, []).append(dur)
+        awake_total = sum(by_phase.get(1, [])) or sum(d for p, v in by_phase.items() for d in v)
+
+        for phase in sorted(by_phase, key=lambda p: (p & ~PHASE_FAILED, p)):
+            durs = by_phase[phase]
+            name = phase_name(phase)
+            share = 100.0 * sum(durs) / awake_total if awake_total else 0.0
+            print(f"  {name:<14} {len(durs):>5} {statistics.median(durs):>8.0f} {percentile(durs, 90):>8.0f} "
+                  f"{percentile(durs, 99):>8.0f} {max(durs):>8} {share:>5.1f}%")
+            if not opts.no_hist:
+                for line in histogram(durs):
+                    print(line)
+
+        model = power.get(src)
+        if model is None:
+            print("  (no power model for this source)")
+            continue
+        per_cycle = [cycle_mah(c, model) for c in cycles]
+        awake_mah = statistics.mean(per_cycle)
+        sleep_mah = model["sleep_ma"] * model["period_s"] / 3600.0
+        print(f"  Energy: awake {awake_mah:.4f} mAh/cycle (p99 {percentile(per_cycle, 99):.4f})", end="")
+        if sleep_mah:
+            print(f" + sleep {sleep_mah:.4f} mAh -> {awake_mah + sleep_mah:.4f} mAh/cycle")
+        else:
+            print()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,113 @@
+#include "FarmTrace.h"
+
+#ifdef FARM_TRACE
+
+#define FARM_TRACE_STATE_MAGIC 0x46545231UL // "FTR1"
+
+typedef struct {
+    uint32_t magic;
+    uint8_t head;   // Next write slot
+    uint8_t count;  // Valid records (oldest = head - count)
+    uint8_t cycle;
+    uint8_t reserved;
+    FarmTraceRecord ring[FARM_TRACE_RING_SIZE];
+} FarmTraceState;
+
+// --- STORAGE ---
+// ESP32: RTC slow memory keeps the ring across deep sleep.
+// ESP8266: plain RAM, mirrored to RTC user memory by farmTracePersist().
+#if defined(ESP32)
+RTC_DATA_ATTR static FarmTraceState traceState;
+#else
+static FarmTraceState traceState;
+#endif
+
+static uint32_t cycleStartMs = 0;
+static uint32_t phaseStartMs[TP_MAX_PHASE];
+static uint16_t openPhases = 0; // Bitmask of phases with a pending Begin
+static bool stateLoaded = false;
+
+static void loadState() {
+    if (stateLoaded) return;
+    stateLoaded = true;
+#if defined(ESP8266)
+    ESP.rtcUserMemoryRead(0, (uint32_t *)&traceState, sizeof(traceState));
+#endif
+    if (traceState.magic != FARM_TRACE_STATE_MAGIC || traceState.count > FARM_TRACE_RING_SIZE
+        || traceState.head >= FARM_TRACE_RING_SIZE) {
+        memset(&traceState, 0, sizeof(traceState));
+        traceState.magic = FARM_TRACE_STATE_MAGIC;
+    }
+}
+
+static uint16_t clamp16(uint32_t v) {
+    return v > 0xFFFF ? 0xFFFF : (uint16_t)v;
+}
+
+void farmTraceNewCycle() {
+    loadState();
+    traceState.cycle++;
+    cycleStartMs = millis();
+}
+
+void farmTraceBegin(uint8_t phase) {
+    if (phase >= TP_MAX_PHASE) return;
+    loadState();
+    phaseStartMs[phase] = millis();
+    openPhases |= (1u << phase);
+}
+
+void farmTraceEnd(uint8_t phase, bool ok) {
+    if (phase >= TP_MAX_PHASE || !(openPhases & (1u << phase))) return;
+    openPhases &= ~(1u << phase);
+
+    uint32_t now = millis();
+    uint32_t start = phaseStartMs[phase];
+    FarmTraceRecord &rec = traceState.ring[traceState.head];
+    rec.phase = ok ? phase : (phase | FARM_TRACE_FAILED);
+    rec.cycle = traceState.cycle;
+    rec.start_cs = clamp16(start >= cycleStartMs ? (start - cycleStartMs) / 10 : 0);
+    rec.dur_ms = clamp16(now - start);
+
+    traceState.head = (traceState.head + 1) % FARM_TRACE_RING_SIZE;
+    if (traceState.count < FARM_TRACE_RING_SIZE) traceState.count++; // Else oldest is overwritten
+}
+
+void farmTracePersist() {
+#if defined(ESP8266)
+    loadState();
+    ESP.rtcUserMemoryWrite(0, (uint32_t *)&traceState, sizeof(traceState));
+#endif
+}
+
+size_t farmTraceExportFrame(uint8_t sourceId, uint8_t *out, size_t cap) {
+    loadState();
+    if (cap < FARM_TRACE_FRAME_HDR) return 0;
+    if (cap > FARM_TRACE_FRAME_MAX) cap = FARM_TRACE_FRAME_MAX;
+
+    size_t n = (cap - FARM_TRACE_FRAME_HDR) / sizeof(FarmTraceRecord);
+    if (n > traceState.count) n = traceState.count;
+
+    uint8_t tail = (traceState.head + FARM_TRACE_RING_SIZE - traceState.count) % FARM_TRACE_RING_SIZE;
+    out[0] = FARM_TRACE_FRAME_MAGIC0;
+    out[1] = FARM_TRACE_FRAME_MAGIC1;
+    out[2] = sourceId;
+    out[3] = (uint8_t)n;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(out + FARM_TRACE_FRAME_HDR + i * sizeof(FarmTraceRecord),
+               &traceState.ring[(tail + i) % FARM_TRACE_RING_SIZE], sizeof(FarmTraceRecord));
+    }
+    traceState.count -= n;
+    return FARM_TRACE_FRAME_HDR + n * sizeof(FarmTraceRecord);
+}
+
+void farmTraceFrameToHex(const uint8_t *frame, size_t len, String &out) {
+    static const char hexChars[] = "0123456789abcdef";
+    out.reserve(out.length() + len * 2);
+    for (size_t i = 0; i < len; i++) {
+        out += hexChars[frame[i] >> 4];
+        out += hexChars[frame[i] & 0x0F];
+    }
+}
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * FARM TRACE - Phase-Level Timing Records (Hub + Spokes)
+ *
+ * Tracepoints write compact 6-byte phase records into a fixed ring buffer.
+ * On ESP32 the ring lives in RTC memory and survives deep sleep; on ESP8266
+ * call TRACE_PERSIST() right before ESP.deepSleep() to copy it into RTC
+ * user memory (restored by TRACE_NEW_CYCLE() on the next boot).
+ *
+ * Build with -DFARM_TRACE to enable. Without it every TRACE_* macro compiles
+ * to nothing; only the frame helpers used by the Hub to route packets remain.
+ *
+ * Decoder: backend/tools/trace_report.py (keep the phase IDs in sync).
+ */
+#pragma once
+#include <Arduino.h>
+
+// --- PHASE IDS (shared by all devices; append only) ---
+enum FarmTracePhase : uint8_t {
+    TP_AWAKE         = 1,  // Whole wake cycle (boot -> deep sleep)
+    TP_RTC_ALIGN     = 2,  // Spoke 1: alignToSlot() hold
+    TP_SENSOR_WARMUP = 3,  // Spoke 1: soil sensor power-up delay
+    TP_ESPNOW_SEND   = 4,  // Spokes: ESP-NOW transmit (incl. settle delay)
+    TP_HUB_PING      = 5,  // Spoke 2: waiting for Hub ACK
+    TP_CAM_INIT      = 6,  // Spoke 2: esp_camera_init()
+    TP_CAM_WARMUP    = 7,  // Spoke 2: auto-exposure warm-up
+    TP_CAM_CAPTURE   = 8,  // Spoke 2: esp_camera_fb_get()
+    TP_MODEM_SYNC    = 9,  // Hub: waiting for modem AT response
+    TP_GPRS_ATTACH   = 10, // Hub: +QIACT context activation
+    TP_HTTP_URL      = 11, // Hub: AT+QHTTPURL handshake
+    TP_HTTP_GET      = 12, // Hub: AT+QHTTPGET wait
+    TP_HTTP_POST     = 13, // Hub: image AT+QHTTPPOST stream + wait
+    TP_SMS_SEND      = 14, // Hub: roll call SMS
+    TP_MAX_PHASE     = 16
+};
+
+// --- RECORD & FRAME FORMAT ---
+// Little-endian, packed. start_cs is the phase start relative to the cycle
+// start in 10 ms units; both time fields saturate at 0xFFFF.
+// A phase that ended in a failure or timeout has FARM_TRACE_FAILED set in
+// its phase byte (see TRACE_END_RESULT).
+#define FARM_TRACE_FAILED 0x80
+
+typedef struct __attribute__((packed)) FarmTraceRecord {
+    uint8_t  phase;     // FarmTracePhase, | FARM_TRACE_FAILED
+    uint8_t  cycle;     // Wraps at 256
+    uint16_t start_cs;
+    uint16_t dur_ms;
+} FarmTraceRecord;
+
+#define FARM_TRACE_RING_SIZE   32
+#define FARM_TRACE_FRAME_MAGIC0 'F'
+#define FARM_TRACE_FRAME_MAGIC1 'T'
+#define FARM_TRACE_FRAME_HDR    4   // magic0, magic1, source id, record count
+#define FARM_TRACE_FRAME_BYTES(n) (FARM_TRACE_FRAME_HDR + (n) * sizeof(FarmTraceRecord))
+#define FARM_TRACE_FRAME_MAX    FARM_TRACE_FRAME_BYTES(40) // Fits ESP-NOW 250
+
+// Records shipped per frame. Keeps the Hub's telemetry URL (hex-encoded
+// Hub + Spoke frames) inside the modem's AT+QHTTPURL limit.
+#define FARM_TRACE_SHIP_SPOKE   20
+#define FARM_TRACE_SHIP_HUB     12
+
+// True if an ESP-NOW payload is a trace frame (always compiled: the Hub must
+// keep these out of the image buffer even when its own tracing is off).
+inline bool farmTraceIsFrame(const uint8_t *data, int len) {
+    return len >= FARM_TRACE_FRAME_HDR && len <= (int)FARM_TRACE_FRAME_MAX
+        && data[0] == FARM_TRACE_FRAME_MAGIC0 && data[1] == FARM_TRACE_FRAME_MAGIC1
+        && len == (int)(FARM_TRACE_FRAME_HDR + data[3] * sizeof(FarmTraceRecord));
+}
+
+#ifdef FARM_TRACE
+
+void farmTraceNewCycle();
+void farmTraceBegin(uint8_t phase);
+void farmTraceEnd(uint8_t phase, bool ok);
+void farmTracePersist();
+
+// Drains the oldest records that fit in `cap` into a frame. Returns bytes written.
+size_t farmTraceExportFrame(uint8_t sourceId, uint8_t *out, size_t cap);
+
+// Appends a binary frame to `out` as hex (for URL query params).
+void farmTraceFrameToHex(const uint8_t *frame, size_t len, String &out);
+
+#define TRACE_NEW_CYCLE()  farmTraceNewCycle()
+#define TRACE_BEGIN(p)     farmTraceBegin(p)
+#define TRACE_END(p)       farmTraceEnd(p, true)
+#define TRACE_END_RESULT(p, ok) farmTraceEnd(p, ok) // Use on exchanges that can fail
+#define TRACE_PERSIST()    farmTracePersist()
+
+#else
+
+#define TRACE_NEW_CYCLE()  do {} while (0)
+#define TRACE_BEGIN(p)     do {} while (0)
+#define TRACE_END(p)       do {} while (0)
+#define TRACE_END_RESULT(p, ok) do {} while (0)
+#define TRACE_PERSIST()    do {} while (0)
+
+#endif
@@ -0,0 +1,173 @@
+/**
+ * SpokeSeries Host Benchmark
+ *
+ * Feeds a year of synthetic Spoke 1 readings (07:00-19:00, every 30 min,
+ * a few seconds of jitter, drying curve + irrigation events) through the
+ * Hub's SpokeSeries store and reports memory per spoke-day, update cost and
+ * last24h() query cost. Also checks decode round-trip and 24h summaries
+ * against a brute-force reference.
+ *
+ * Build & run (from src-hub/):
+ *   g++ -O2 -std=c++11 -Ilib/SpokeSeries bench/spoke_series_bench.cpp lib/SpokeSeries/SpokeSeries.cpp -o /tmp/spoke_series_bench
+ *   /tmp/spoke_series_bench
+ */
+#include <SpokeSeries.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+struct Reading {
+    uint32_t ts;
+    int16_t value;
+};
+
+static const uint32_t START_TS = 1767225600; // 2026-01-01 00:00:00 UTC
+static const int DAYS = 365;
+
+// --- SYNTHETIC DATA ---
+static std::vector<Reading> makeYear(bool rawChannel, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> jitter(-3, 3);
+    std::normal_distribution<double> noise(0.0, rawChannel ? 4.0 : 0.8);
+    std::uniform_int_distribution<int> irrigateEvery(3, 5);
+
+    std::vector<Reading> out;
+    double pct = 60.0;
+    int nextIrrigation = irrigateEvery(rng);
+    for (int day = 0; day < DAYS; day++) {
+        if (day == nextIrrigation) {
+            pct = 85.0 + (rng() % 10);
+            nextIrrigation = day + irrigateEvery(rng);
+        }
+        for (int hour = 7; hour < 19; hour++) {
+            for (int minute : {28, 58}) {
+                pct -= 0.35; // Daytime drying
+                if (pct < 5) pct = 5;
+                double v = pct + noise(rng);
+                if (rawChannel) v = 700 - v * 4; // DRY_SOIL=700, WET_SOIL=300
+                uint32_t ts = START_TS + day * 86400 + hour * 3600 + minute * 60 + 25 + jitter(rng);
+                out.push_back({ts, (int16_t)(v + 0.5)});
+            }
+        }
+        pct -= 2.0; // Overnight drying
+    }
+    return out;
+}
+
+// --- REFERENCE ---
+// Independent of the bucket layout: every reading from HH:00 yesterday
+// (HH = current hour) up to `now`.
+static SeriesSummary bruteForce24h(const std::vector<Reading> &data, size_t upto, uint32_t now) {
+    SeriesSummary s = {0, 0, 0, 0.0f, 0.0f};
+    long sum = 0;
+    uint32_t windowStart = (now / 3600) * 3600 - 24 * 3600;
+    for (size_t i = 0; i < upto; i++) {
+        if (data[i].ts < windowStart || data[i].ts > now) continue;
+        if (s.count == 0 || data[i].value < s.min) s.min = data[i].value;
+        if (s.count == 0 || data[i].value > s.max) s.max = data[i].value;
+        s.count++;
+        sum += data[i].value;
+    }
+    if (s.count) s.mean = (float)sum / s.count;
+    return s;
+}
+
+struct DecodeCheck {
+    const std::vector<Reading> *data;
+    size_t next;
+    size_t mismatches;
+};
+
+static void checkSample(uint32_t ts, int16_t value, void *ctx) {
+    DecodeCheck *c = (DecodeCheck *)ctx;
+    const Reading &r = (*c->data)[c->next++];
+    if (r.ts != ts || r.value != value) c->mismatches++;
+}
+
+static int runChannel(const char *name, bool rawChannel) {
+    typedef std::chrono::steady_clock Clock;
+    std::vector<Reading> data = makeYear(rawChannel, 42);
+
+    static SpokeSeries series; // Zero-initialised, like RTC_DATA_ATTR on the Hub
+    series.clear();
+
+    // 1. Update cost
+    Clock::time_point t0 = Clock::now();
+    for (const Reading &r : data) series.add(r.ts, r.value);
+    double addNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / data.size();
+
+    // 2. Query cost
+    const int QUERIES = 1000000;
+    uint32_t now = data.back().ts;
+    volatile uint32_t sink = 0;
+    t0 = Clock::now();
+    for (int i = 0; i < QUERIES; i++) sink += series.last24h(now + (i & 1)).count;
+    double queryNs = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / QUERIES;
+
+    // 3. Memory per spoke-day
+    uint32_t retained = series.retainedCount();
+    const Reading &oldest = data[data.size() - retained];
+    double spanDays = (data.back().ts - oldest.ts) / 86400.0;
+    double bitsPerSample = series.storageBytes() * 8.0 / retained;
+    double perDay = retained / spanDays;
+
+    // 4. Correctness: decode round-trip over the retained window
+    DecodeCheck check = {&data, data.size() - retained, 0};
+    size_t visited = series.forEach(checkSample, &check);
+
+    // 5. Correctness: 24h summaries at every morning roll call (07:00)
+    SpokeSeries replay;
+    replay.clear();
+    int summaryErrors = 0;
+    size_t fed = 0;
+    for (int day = 1; day < DAYS; day++) {
+        uint32_t rollCall = START_TS + day * 86400 + 7 * 3600;
+        while (fed < data.size() && data[fed].ts < rollCall) {
+            replay.add(data[fed].ts, data[fed].value);
+            fed++;
+        }
+        SeriesSummary got = replay.last24h(rollCall);
+        SeriesSummary want = bruteForce24h(data, fed, rollCall);
+        if (want.count != 24) summaryErrors++; // Must include yesterday's 07:28/07:58
+        if (got.count != want.count || got.min != want.min || got.max != want.max
+            || (got.count && std::abs(got.mean - want.mean) > 0.01f)) {
+            summaryErrors++;
+        }
+    }
+
+    // 6. RTC corrected backwards by a day: store must keep recording
+    SpokeSeries jump;
+    jump.clear();
+    jump.add(START_TS + 86400 + 100, 40);
+    bool stepDropped = !jump.add(START_TS + 86400 + 40, 41);   // Small step back: dropped
+    bool resetOk = jump.add(START_TS + 100, 42)                // Large step back: reset
+                   && jump.add(START_TS + 1900, 43)
+                   && jump.retainedCount() == 2 && jump.last24h(START_TS + 2000).count == 2;
+
+    SeriesSummary last = series.last24h(now);
+    printf("\n=== CHANNEL: %s ===\n", name);
+    printf("Readings fed:        %zu over %d days\n", data.size(), DAYS);
+    printf("Store footprint:     %zu bytes/spoke (%zu sample blocks + aggregates)\n",
+           sizeof(SpokeSeries), series.storageBytes());
+    printf("Retained:            %u samples, %.1f days\n", retained, spanDays);
+    printf("Encoding:            %.1f bits/sample (raw 48) -> %.0f bytes per spoke-day\n",
+           bitsPerSample, bitsPerSample * perDay / 8.0);
+    printf("add():               %.1f ns/reading\n", addNs);
+    printf("last24h():           %.1f ns/query\n", queryNs);
+    printf("Last 24h:            n=%u min=%d max=%d mean=%.1f ewma=%.1f\n",
+           last.count, last.min, last.max, last.mean, last.ewma);
+    printf("Decode round-trip:   %zu samples, %zu mismatches\n", visited, check.mismatches);
+    printf("24h summary checks:  %d days, %d mismatches\n", DAYS - 1, summaryErrors);
+    printf("RTC backward jump:   %s\n", (stepDropped && resetOk) ? "ok" : "FAILED");
+
+    return (check.mismatches || visited != retained || summaryErrors || !stepDropped || !resetOk) ? 1 : 0;
+}
+
+int main() {
+    int rc = runChannel("moisture_pct", false);
+    rc |= runChannel("moisture_raw", true);
+    return rc;
+}
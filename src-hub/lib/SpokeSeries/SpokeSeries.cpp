@@ -0,0 +1,205 @@
+#include "SpokeSeries.h"
+#include <string.h>
+
+static const uint16_t BLOCK_BITS = sizeof(((SeriesBlock *)0)->bits) * 8;
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// --- BIT CODES ---
+// Timestamp delta-of-delta:   0 | 10+7 | 110+12 | 1110+20 (zigzag) | 1111+32 (raw dt)
+// Value delta:                0 | 10+4 | 110+8 (zigzag)            | 111+16  (raw value)
+static void encodeTime(uint32_t dt, int32_t prevDt, uint64_t &code, uint8_t &len) {
+    int64_t dod = (int64_t)dt - prevDt;
+    if (dod == 0) { code = 0; len = 1; return; }
+    if (dod > -(1 << 19) && dod < (1 << 19)) {
+        uint32_t zz = zigzag((int32_t)dod);
+        if (zz < (1u << 7))  { code = (0x2ull << 7) | zz;  len = 9;  return; }
+        if (zz < (1u << 12)) { code = (0x6ull << 12) | zz; len = 15; return; }
+        if (zz < (1u << 20)) { code = (0xEull << 20) | zz; len = 24; return; }
+    }
+    code = (0xFull << 32) | dt;
+    len = 36;
+}
+
+static void encodeValue(int16_t value, int16_t prev, uint64_t &code, uint8_t &len) {
+    int32_t d = (int32_t)value - prev;
+    if (d == 0) { code = 0; len = 1; return; }
+    uint32_t zz = zigzag(d);
+    if (zz < (1u << 4)) { code = (0x2ull << 4) | zz; len = 6;  return; }
+    if (zz < (1u << 8)) { code = (0x6ull << 8) | zz; len = 11; return; }
+    code = (0x7ull << 16) | (uint16_t)value;
+    len = 19;
+}
+
+// --- BIT READER ---
+struct BitReader {
+    const uint8_t *buf;
+    uint16_t pos;
+
+    uint32_t read(uint8_t n) {
+        uint32_t v = 0;
+        while (n--) {
+            v = (v << 1) | ((buf[pos >> 3] >> (7 - (pos & 7))) & 1);
+            pos++;
+        }
+        return v;
+    }
+    // Counts leading 1s up to `max` (consumes the terminating 0 if present)
+    uint8_t prefix(uint8_t max) {
+        uint8_t ones = 0;
+        while (ones < max && read(1)) ones++;
+        return ones;
+    }
+};
+
+// --- WRITER ---
+void SpokeSeries::clear() {
+    memset(this, 0, sizeof(*this));
+}
+
+bool SpokeSeries::appendBits(uint64_t code, uint8_t len) {
+    if (bitPos + len > BLOCK_BITS) return false;
+    uint8_t *bits = blocks[head].bits;
+    while (len--) {
+        uint16_t byte = bitPos >> 3;
+        uint8_t mask = 0x80 >> (bitPos & 7);
+        if ((code >> len) & 1) bits[byte] |= mask;
+        else bits[byte] &= ~mask;
+        bitPos++;
+    }
+    return true;
+}
+
+void SpokeSeries::startBlock(uint32_t ts, int16_t value) {
+    if (used > 0) head = (head + 1) % SPOKE_SERIES_NUM_BLOCKS;
+    if (used < SPOKE_SERIES_NUM_BLOCKS) used++; // Else the oldest block is overwritten
+    SeriesBlock &b = blocks[head];
+    b.t0 = ts;
+    b.v0 = value;
+    b.n = 1;
+    bitPos = 0;
+    lastDt = 0;
+}
+
+bool SpokeSeries::add(uint32_t ts, int16_t value) {
+    if (total > 0 && ts < lastTs) {
+        if (lastTs - ts <= SPOKE_SERIES_MAX_BACKSTEP) return false;
+        clear();
+    }
+
+    if (used == 0) {
+        startBlock(ts, value);
+    } else {
+        uint32_t dt = ts - lastTs;
+        uint64_t tCode, vCode;
+        uint8_t tLen, vLen;
+        encodeTime(dt, lastDt, tCode, tLen);
+        encodeValue(value, lastValue, vCode, vLen);
+
+        if (appendBits((tCode << vLen) | vCode, tLen + vLen)) {
+            blocks[head].n++;
+            lastDt = (int32_t)dt;
+        } else {
+            startBlock(ts, value);
+        }
+    }
+
+    lastTs = ts;
+    lastValue = value;
+    updateAggregates(ts, value);
+    return true;
+}
+
+// --- AGGREGATES ---
+void SpokeSeries::updateAggregates(uint32_t ts, int16_t value) {
+    uint16_t hour = (uint16_t)(ts / 3600);
+    SeriesBucket &b = buckets[(ts / 3600) % SPOKE_SERIES_BUCKETS];
+    if (b.count == 0 || b.hour != hour) {
+        b.hour = hour;
+        b.sum = 0;
+        b.count = 0;
+        b.min = value;
+        b.max = value;
+    }
+    b.sum += value;
+    if (b.count < 0xFFFF) b.count++;
+    if (value < b.min) b.min = value;
+    if (value > b.max) b.max = value;
+
+    if (total == 0) {
+        lifeMin = lifeMax = value;
+        ewmaQ8 = (int32_t)value << 8;
+    } else {
+        if (value < lifeMin) lifeMin = value;
+        if (value > lifeMax) lifeMax = value;
+        ewmaQ8 += (((int32_t)value << 8) - ewmaQ8) >> SPOKE_SERIES_EWMA_SHIFT;
+    }
+    total++;
+    totalSum += value;
+}
+
+SeriesSummary SpokeSeries::last24h(uint32_t now) const {
+    SeriesSummary s = {0, 0, 0, 0.0f, ewmaQ8 / 256.0f};
+    uint16_t nowHour = (uint16_t)(now / 3600);
+    int32_t sum = 0;
+    for (int i = 0; i < SPOKE_SERIES_BUCKETS; i++) {
+        const SeriesBucket &b = buckets[i];
+        if (b.count == 0 || (uint16_t)(nowHour - b.hour) >= SPOKE_SERIES_BUCKETS) continue;
+        if (s.count == 0 || b.min < s.min) s.min = b.min;
+        if (s.count == 0 || b.max > s.max) s.max = b.max;
+        s.count += b.count;
+        sum += b.sum;
+    }
+    if (s.count) s.mean = (float)sum / s.count;
+    return s;
+}
+
+SeriesSummary SpokeSeries::lifetime() const {
+    SeriesSummary s = {total, lifeMin, lifeMax, 0.0f, ewmaQ8 / 256.0f};
+    if (total) s.mean = (float)((double)totalSum / total);
+    return s;
+}
+
+// --- READER ---
+size_t SpokeSeries::forEach(void (*fn)(uint32_t ts, int16_t value, void *ctx), void *ctx) const {
+    size_t visited = 0;
+    uint8_t idx = (head + SPOKE_SERIES_NUM_BLOCKS + 1 - used) % SPOKE_SERIES_NUM_BLOCKS;
+    for (uint8_t k = 0; k < used; k++, idx = (idx + 1) % SPOKE_SERIES_NUM_BLOCKS) {
+        const SeriesBlock &b = blocks[idx];
+        uint32_t ts = b.t0;
+        int16_t value = b.v0;
+        int32_t dt = 0;
+        fn(ts, value, ctx);
+        visited++;
+
+        BitReader r = {b.bits, 0};
+        for (uint16_t i = 1; i < b.n; i++) {
+            switch (r.prefix(4)) {
+                case 0: break;
+                case 1: dt += unzigzag(r.read(7)); break;
+                case 2: dt += unzigzag(r.read(12)); break;
+                case 3: dt += unzigzag(r.read(20)); break;
+                default: dt = (int32_t)r.read(32); break;
+            }
+            switch (r.prefix(3)) {
+                case 0: break;
+                case 1: value += (int16_t)unzigzag(r.read(4)); break;
+                case 2: value += (int16_t)unzigzag(r.read(8)); break;
+                default: value = (int16_t)r.read(16); break;
+            }
+            ts += (uint32_t)dt;
+            fn(ts, value, ctx);
+            visited++;
+        }
+    }
+    return visited;
+}
+
+uint32_t SpokeSeries::retainedCount() const {
+    uint32_t n = 0;
+    for (uint8_t k = 0; k < used; k++) {
+        n += blocks[(head + SPOKE_SERIES_NUM_BLOCKS - k) % SPOKE_SERIES_NUM_BLOCKS].n;
+    }
+    return n;
+}
@@ -0,0 +1,98 @@
+/**
+ * SPOKE SERIES - Fixed-Memory Time-Series Store (Hub)
+ *
+ * Keeps each Spoke's recent readings on the Hub so summaries can be answered
+ * locally (e.g. Morning Roll Call SMS) without a cloud query.
+ *
+ * Storage: a ring of 64-byte blocks. Each block holds a raw first sample,
+ * then bit-packed deltas: delta-of-delta for timestamps, delta for values.
+ * When full, the oldest block is overwritten.
+ *
+ * Aggregates: 25 hourly buckets (min/max/sum/count) plus lifetime min/max/
+ * mean and an EWMA, all updated incrementally per reading. last24h() merges
+ * the buckets, so its cost does not depend on how many readings exist.
+ *
+ * No constructor on purpose: a zero-filled object is a valid empty store,
+ * so instances can live in RTC_DATA_ATTR memory across deep sleep.
+ *
+ * Plain C++ (no Arduino headers) so it can be benchmarked on the host:
+ * see src-hub/bench/spoke_series_bench.cpp.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPOKE_SERIES_BLOCK_BYTES 64
+#define SPOKE_SERIES_NUM_BLOCKS  12
+#define SPOKE_SERIES_BUCKETS     25  // Current hour + the 24 before it
+#define SPOKE_SERIES_EWMA_SHIFT  3   // alpha = 1/8
+#define SPOKE_SERIES_MAX_BACKSTEP 3600 // Larger backward jumps reset the store
+
+typedef struct SeriesSummary {
+    uint32_t count;
+    int16_t  min;
+    int16_t  max;
+    float    mean;
+    float    ewma;
+} SeriesSummary;
+
+typedef struct SeriesBlock {
+    uint32_t t0;        // Timestamp of first sample (unix seconds)
+    int16_t  v0;        // Value of first sample
+    uint16_t n;         // Samples in this block (0 = unused)
+    uint8_t  bits[SPOKE_SERIES_BLOCK_BYTES - 8];
+} SeriesBlock;
+
+typedef struct SeriesBucket {
+    int32_t  sum;
+    uint16_t count;
+    uint16_t hour;      // Hours since epoch (mod 65536) this bucket covers
+    int16_t  min;
+    int16_t  max;
+} SeriesBucket;
+
+class SpokeSeries {
+public:
+    void clear();
+
+    // Appends a reading. A reading slightly older than the previous one is
+    // dropped (returns false). A jump back of more than
+    // SPOKE_SERIES_MAX_BACKSTEP means the RTC was corrected, so the store is
+    // cleared and restarts from this reading instead of stalling until
+    // real time catches up.
+    bool add(uint32_t ts, int16_t value);
+
+    // Readings since HH:00 yesterday, where HH is the current hour (24-25 h,
+    // so the full last 24 h is always covered). count == 0 if none.
+    SeriesSummary last24h(uint32_t now) const;
+    SeriesSummary lifetime() const;
+
+    // Decodes retained readings oldest -> newest. Returns samples visited.
+    size_t forEach(void (*fn)(uint32_t ts, int16_t value, void *ctx), void *ctx) const;
+
+    uint32_t retainedCount() const;
+    size_t   storageBytes() const { return sizeof(blocks); }
+
+private:
+    SeriesBlock  blocks[SPOKE_SERIES_NUM_BLOCKS];
+    SeriesBucket buckets[SPOKE_SERIES_BUCKETS];
+
+    // Writer state for the current (head) block
+    uint8_t  head;
+    uint8_t  used;          // Blocks holding data
+    uint16_t bitPos;
+    uint32_t lastTs;
+    int32_t  lastDt;
+    int16_t  lastValue;
+
+    // Lifetime aggregates
+    uint32_t total;
+    int64_t  totalSum;
+    int32_t  ewmaQ8;        // EWMA in 1/256 units
+    int16_t  lifeMin;
+    int16_t  lifeMax;
+
+    bool appendBits(uint64_t code, uint8_t len);
+    void startBlock(uint32_t ts, int16_t value);
+    void updateAggregates(uint32_t ts, int16_t value);
+};
@@ -9,6 +9,8 @@
 #include <esp_now.h>
 #include <RTClib.h>
 #include <TinyGsmClient.h>
+#include <FarmTrace.h>
+#include <SpokeSeries.h>
 #include "secrets.h"
 
 // --- HARDWARE CONFIG ---
@@ -30,8 +32,12 @@ typedef struct struct_message {
     int id;
     int moisture;
     float voltage;
+    int raw;        // Appended later; older Spokes send the 12-byte struct without it
 } struct_message;
 
+// Old Spoke firmware packet size (id, moisture, voltage only)
+const int LEGACY_MSG_SIZE = offsetof(struct_message, raw);
+
 volatile bool newSensorData = false;
 volatile bool isModemBusy = false; 
 struct_message incomingData;
@@ -40,18 +46,35 @@ uint8_t *imgBuffer;
 volatile size_t imgSize = 0;
 volatile unsigned long lastImgPacketTime = 0;
 
+// Spoke IDs 1..3 (index 0 is the Hub itself)
+const int MAX_SPOKES = 4;
+
+// Per-Spoke moisture history, kept in RTC memory so the 07:00 Roll Call
+// can still summarise yesterday after Night Mode deep sleep.
+RTC_DATA_ATTR SpokeSeries spokeHistory[MAX_SPOKES - 1];
+
+#ifdef FARM_TRACE
+// Latest trace frame per Spoke ID, attached to that Spoke's next upload.
+// Written by the ESP-NOW callback (Wi-Fi task), read by loop(): guarded by traceMux.
+uint8_t spokeTrace[MAX_SPOKES][FARM_TRACE_FRAME_MAX];
+size_t spokeTraceLen[MAX_SPOKES] = {0};
+portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
 // --- PROTOTYPES ---
 void IRAM_ATTR OnDataRecv(const esp_now_recv_info_t * info, const uint8_t *data, int len);
 void uploadTelemetry(struct_message* data);
 void uploadImage();
 float readHubBattery();
 void sendStartupSMS();
+void appendTraceParam(String &url, int spokeId);
 
 // --- SETUP ---
 void setup() {
     Serial.begin(115200);
     delay(2000);
     Serial.println("\n\n=== HUB STARTING V5.0.2 [STABLE] ===");
+    TRACE_NEW_CYCLE();
 
     imgBuffer = (uint8_t *)malloc(MAX_IMG_SIZE);
     
@@ -67,12 +90,14 @@ void setup() {
     
     // 3. Wait for Modem to respond to AT
     Serial.print(">> Syncing Modem... ");
+    TRACE_BEGIN(TP_MODEM_SYNC);
     unsigned long start = millis();
     bool alive = false;
     while (millis() - start < 15000) {
         if (modem.testAT()) { alive = true; break; }
         delay(500);
     }
+    TRACE_END_RESULT(TP_MODEM_SYNC, alive);
 
     if (!alive) {
         Serial.println("FAIL. Restarting...");
@@ -85,7 +110,10 @@ void setup() {
     modem.sendAT("+QICSGP=1,3,\"jionet\"");
     modem.sendAT("+QIACT=1");
  
-    if (modem.waitResponse(10000) == 1) {
+    TRACE_BEGIN(TP_GPRS_ATTACH);
+    int attached = modem.waitResponse(10000);
+    TRACE_END_RESULT(TP_GPRS_ATTACH, attached == 1);
+    if (attached == 1) {
         delay(5000); // Wait for signal to register
     
         // --- 7:00 AM MORNING ROLL CALL ONLY ---
@@ -135,6 +163,10 @@ void loop() {
     if (newSensorData && !isModemBusy) {
         newSensorData = false;
         isModemBusy = true;
+        TRACE_NEW_CYCLE();
+        if (incomingData.id > 0 && incomingData.id < MAX_SPOKES && now.year() >= 2025) {
+            spokeHistory[incomingData.id - 1].add(now.unixtime(), incomingData.moisture);
+        }
         incomingData.voltage = readHubBattery(); 
         uploadTelemetry(&incomingData);
         isModemBusy = false;
@@ -164,20 +196,30 @@ float readHubBattery() {
 void uploadTelemetry(struct_message* data) {
     Serial.println("\n--- [TELEMETRY] ---");
     String url = String(SECRETS_GCP_URL) + "/?token=FARM_SEC&device_id=spoke_" + String(data->id);
+    if (data->raw >= 0) url += "&raw=" + String(data->raw);
     url += "&pct=" + String(data->moisture) + "&bat=" + String(data->voltage);
+    appendTraceParam(url, data->id);
 
     Serial.println("URL: " + url);
     modemSerial.print("AT+QHTTPURL=");
     modemSerial.print(url.length());
     modemSerial.print(",80\r\n");
 
-    if (modem.waitResponse(10000, "CONNECT") == 1) {
+    // Every exit path ends its phase; failures and timeouts are flagged
+    TRACE_BEGIN(TP_HTTP_URL);
+    bool urlSet = modem.waitResponse(10000, "CONNECT") == 1;
+    if (urlSet) {
         modemSerial.print(url);
-        if (modem.waitResponse(5000, "OK") == 1) {
-            modemSerial.print("AT+QHTTPGET=80\r\n");
-            modem.waitResponse(30000, "+QHTTPGET: 0,200");
-            Serial.println(">> Success.");
-        }
+        urlSet = modem.waitResponse(5000, "OK") == 1;
+    }
+    TRACE_END_RESULT(TP_HTTP_URL, urlSet);
+
+    if (urlSet) {
+        TRACE_BEGIN(TP_HTTP_GET);
+        modemSerial.print("AT+QHTTPGET=80\r\n");
+        bool got = modem.waitResponse(30000, "+QHTTPGET: 0,200") == 1;
+        TRACE_END_RESULT(TP_HTTP_GET, got);
+        Serial.println(got ? ">> Success." : ">> HTTP GET failed or timed out.");
     }
     Serial.println("--- [END] ---");
 }
@@ -191,15 +233,23 @@ void uploadImage() {
     modem.sendAT("E0"); modem.waitResponse();
 
     String url = String(SECRETS_GCP_URL) + "/?token=FARM_SEC&device_id=spoke_2";
+    appendTraceParam(url, 2);
 
     modemSerial.print("AT+QHTTPURL=");
     modemSerial.print(url.length());
     modemSerial.print(",80\r\n");
     
-    if (modem.waitResponse(10000, "CONNECT") == 1) {
+    TRACE_BEGIN(TP_HTTP_URL);
+    bool connected = modem.waitResponse(10000, "CONNECT") == 1;
+    bool urlSet = false;
+    if (connected) {
         modemSerial.print(url);
-        modem.waitResponse(5000, "OK");
+        urlSet = modem.waitResponse(5000, "OK") == 1;
+    }
+    TRACE_END_RESULT(TP_HTTP_URL, urlSet);
+    if (connected && !urlSet) Serial.println(">> URL not acknowledged, posting anyway.");
 
+    if (connected) {
         uint8_t* startPtr = imgBuffer;
         size_t actualSize = imgSize;
         
@@ -213,10 +263,12 @@ void uploadImage() {
             }
         }
 
+        TRACE_BEGIN(TP_HTTP_POST);
         modemSerial.print("AT+QHTTPPOST=");
         modemSerial.print(actualSize);
         modemSerial.print(",80,80\r\n");
 
+        bool posted = false;
         if (modem.waitResponse(10000, "CONNECT") == 1) {
             size_t written = 0;
             while (written < actualSize) {
@@ -227,9 +279,10 @@ void uploadImage() {
                 delay(45); 
                 if (written % 2048 == 0) Serial.print(".");
             }
-            modem.waitResponse(60000, "+QHTTPPOST: 0,200");
-            Serial.println("\n>> Image Success.");
+            posted = modem.waitResponse(60000, "+QHTTPPOST: 0,200") == 1;
+            Serial.println(posted ? "\n>> Image Success." : "\n>> Image POST failed or timed out.");
         }
+        TRACE_END_RESULT(TP_HTTP_POST, posted);
     }
 
     imgSize = 0;
@@ -242,8 +295,23 @@ void uploadImage() {
 }
 
 void IRAM_ATTR OnDataRecv(const esp_now_recv_info_t * info, const uint8_t *data, int len) {
-    if (len == sizeof(struct_message)) {
-        memcpy(&incomingData, data, sizeof(struct_message));
+    // Trace frames are checked first so they never land in the image buffer
+    if (farmTraceIsFrame(data, len)) {
+#ifdef FARM_TRACE
+        int id = data[2];
+        size_t copyLen = (len > (int)sizeof(spokeTrace[0])) ? sizeof(spokeTrace[0]) : (size_t)len;
+        if (id > 0 && id < MAX_SPOKES) {
+            portENTER_CRITICAL(&traceMux);
+            memcpy(spokeTrace[id], data, copyLen);
+            spokeTraceLen[id] = copyLen;
+            portEXIT_CRITICAL(&traceMux);
+        }
+#endif
+        return;
+    }
+    if (len == sizeof(struct_message) || len == LEGACY_MSG_SIZE) {
+        memcpy(&incomingData, data, len);
+        if (len == LEGACY_MSG_SIZE) incomingData.raw = -1; // Not reported
         newSensorData = true;
     } else {
         if (imgSize + len < MAX_IMG_SIZE) {
@@ -278,12 +346,49 @@ void sendStartupSMS() {
     msg += "Bat: " + String(vBat, 2) + "V\n";
     msg += "Signal: " + String(csq) + "/31";
 
+    // Per-Spoke summary since this hour yesterday (from 07:00 at Roll Call),
+    // answered from the local store (no cloud query)
+    if (now.year() >= 2025) {
+        for (int i = 0; i < MAX_SPOKES - 1; i++) {
+            SeriesSummary day = spokeHistory[i].last24h(now.unixtime());
+            if (day.count == 0) continue;
+            msg += "\nS" + String(i + 1) + " since " + String(now.hour()) + "h yday: " + String(day.min) + "-" + String(day.max) + "%";
+            msg += " avg " + String(day.mean, 0) + " n=" + String(day.count);
+        }
+    }
+
     Serial.println(">> Sending to: " + String(SECRETS_ADMIN_PHONE));
     
     // Use the library method directly
-    if (modem.sendSMS(SECRETS_ADMIN_PHONE, msg)) {
+    TRACE_BEGIN(TP_SMS_SEND);
+    bool sent = modem.sendSMS(SECRETS_ADMIN_PHONE, msg);
+    TRACE_END_RESULT(TP_SMS_SEND, sent);
+    if (sent) {
         Serial.println(">> SMS SUCCESS");
     } else {
         Serial.println(">> SMS FAILED (Check balance/Signal)");
     }
+}
+
+// Adds "&trace=<hex>" with the Hub's own phase records plus the given
+// Spoke's latest frame. No-op when tracing is compiled out.
+void appendTraceParam(String &url, int spokeId) {
+#ifdef FARM_TRACE
+    String hex;
+    uint8_t frame[FARM_TRACE_FRAME_BYTES(FARM_TRACE_SHIP_HUB)];
+    size_t len = farmTraceExportFrame(0, frame, sizeof(frame));
+    if (len > FARM_TRACE_FRAME_HDR) farmTraceFrameToHex(frame, len, hex);
+
+    if (spokeId > 0 && spokeId < MAX_SPOKES) {
+        // Snapshot under the lock so a frame arriving mid-encode can't tear it
+        uint8_t spokeFrame[FARM_TRACE_FRAME_MAX];
+        portENTER_CRITICAL(&traceMux);
+        size_t spokeLen = spokeTraceLen[spokeId];
+        memcpy(spokeFrame, spokeTrace[spokeId], spokeLen);
+        spokeTraceLen[spokeId] = 0;
+        portEXIT_CRITICAL(&traceMux);
+        if (spokeLen > 0) farmTraceFrameToHex(spokeFrame, spokeLen, hex);
+    }
+    if (hex.length() > 0) url += "&trace=" + hex;
+#endif
 }
\ No newline at end of file
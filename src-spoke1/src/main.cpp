@@ -3,6 +3,7 @@
 #include <espnow.h>
 #include <Wire.h>
 #include <RTClib.h>
+#include <FarmTrace.h>
 
 // --- CONFIGURATION ---
 // 1. DESTINATION MAC (Update with your Hub's Actual MAC)
@@ -29,9 +30,11 @@ typedef struct __attribute__((packed)) struct_message {
   int id;          // Node ID
   int moisture;    // Percent Value
   float voltage;   // Battery Voltage
+  int raw;         // Raw ADC Value (for recalibration in BigQuery)
 } struct_message;
 
 struct_message myData;
+int lastRawReading = 0; // Set by readSoil()
 
 // --- FUNCTIONS ---
 
@@ -48,10 +51,13 @@ int readSoil() {
   // A. Power ON (Legacy support if using D5, harmless if using 3.3V Direct)
   pinMode(SENSOR_PWR_PIN, OUTPUT);
   digitalWrite(SENSOR_PWR_PIN, HIGH);
+  TRACE_BEGIN(TP_SENSOR_WARMUP);
   delay(800); // Wait for sensor to stabilize
+  TRACE_END(TP_SENSOR_WARMUP);
 
   // B. Read
   int raw = analogRead(SOIL_PIN);
+  lastRawReading = raw;
   Serial.printf("   [Raw Value: %d] ", raw); 
 
   // C. Power OFF (Save Battery!)
@@ -138,7 +144,9 @@ void alignToSlot(DateTime now) {
   
   if (waitMillis > 0) {
     Serial.printf(">> Holding for %ld ms to avoid Camera collision...\n", waitMillis);
+    TRACE_BEGIN(TP_RTC_ALIGN);
     delay(waitMillis);
+    TRACE_END(TP_RTC_ALIGN);
   }
 }
 
@@ -147,6 +155,8 @@ void setup() {
   // Init Serial FIRST so we see boot messages
   Serial.begin(115200);
   Serial.println("\n\n=== SPOKE 1 BOOT ===");
+  TRACE_NEW_CYCLE();
+  TRACE_BEGIN(TP_AWAKE);
 
   // Init I2C for RTC
   Wire.begin(D2, D1); // SDA=D2, SCL=D1
@@ -182,17 +192,30 @@ void setup() {
   esp_now_register_send_cb(OnDataSent);
   esp_now_add_peer(broadcastAddress, ESP_NOW_ROLE_SLAVE, 1, NULL, 0);
 
+#ifdef FARM_TRACE
+  // Ship previous cycles' phase records ahead of the telemetry packet
+  uint8_t traceFrame[FARM_TRACE_FRAME_BYTES(FARM_TRACE_SHIP_SPOKE)];
+  size_t traceLen = farmTraceExportFrame(1, traceFrame, sizeof(traceFrame));
+  if (traceLen > FARM_TRACE_FRAME_HDR) {
+    esp_now_send(broadcastAddress, traceFrame, traceLen);
+    delay(20);
+  }
+#endif
+
   // --- JOB: MEASURE & SEND ---
   int percent = readSoil();
   
   myData.id = 1; 
   myData.moisture = percent;
+  myData.raw = lastRawReading;
   myData.voltage = 0.0; // Battery reading disabled for Spoke 1 (A0 used by sensor)
   
   Serial.println(">> Sending Packet...");
+  TRACE_BEGIN(TP_ESPNOW_SEND);
   esp_now_send(broadcastAddress, (uint8_t *) &myData, sizeof(myData));
   
   delay(200); // Allow time for packet to leave radio
+  TRACE_END(TP_ESPNOW_SEND);
 
   // --- JOB: SLEEP ---
   // Re-read time because we might have waited in alignToSlot
@@ -204,6 +227,8 @@ void setup() {
   
   Serial.printf(">> Done. Sleeping %ld sec.\n", sleepSecs);
   Serial.println(">> Goodnight.");
+  TRACE_END(TP_AWAKE);
+  TRACE_PERSIST();
   
   // Convert to Microseconds for Deep Sleep
   ESP.deepSleep(sleepSecs * 1000000ULL); 
@@ -2,6 +2,7 @@
 #include <WiFi.h>
 #include <esp_now.h>
 #include <esp_camera.h>
+#include <FarmTrace.h>
 
 // 1. CONFIGURATION
 // REPLACE WITH YOUR HUB MAC ADDRESS
@@ -38,6 +39,7 @@ void OnDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
 void deepSleep(int minutes) {
   Serial.printf(">> Sleeping for %d minutes...\n", minutes);
   Serial.flush();
+  TRACE_END(TP_AWAKE); // Ring stays in RTC memory across the sleep
   esp_deep_sleep((uint64_t)minutes * 60 * 1000000);
 }
 
@@ -101,16 +103,23 @@ void runCameraSequence() {
   
   config.fb_count = 1;
 
-  if (esp_camera_init(&config) != ESP_OK) {
+  TRACE_BEGIN(TP_CAM_INIT);
+  bool camReady = esp_camera_init(&config) == ESP_OK;
+  TRACE_END_RESULT(TP_CAM_INIT, camReady);
+  if (!camReady) {
     Serial.println("Camera Init Failed");
     return;
   }
 
   // Warmup (Important for Auto-Exposure to adjust to light)
+  TRACE_BEGIN(TP_CAM_WARMUP);
   delay(2000); 
+  TRACE_END(TP_CAM_WARMUP);
 
   // Capture
+  TRACE_BEGIN(TP_CAM_CAPTURE);
   camera_fb_t * fb = esp_camera_fb_get();
+  TRACE_END_RESULT(TP_CAM_CAPTURE, fb != NULL);
   if(!fb) {
     Serial.println("Capture failed");
     return;
@@ -118,13 +127,17 @@ void runCameraSequence() {
 
   // Send
   Serial.printf("Captured %d bytes (SVGA Mode). Sending...\n", fb->len);
+  TRACE_BEGIN(TP_ESPNOW_SEND);
   sendImageChunked(fb->buf, fb->len);
+  TRACE_END(TP_ESPNOW_SEND);
   
   esp_camera_fb_return(fb);
 }
 
 void setup() {
   Serial.begin(115200);
+  TRACE_NEW_CYCLE();
+  TRACE_BEGIN(TP_AWAKE);
   WiFi.mode(WIFI_STA);
   if (esp_now_init() != ESP_OK) deepSleep(2);
   esp_now_register_send_cb(OnDataSent);
@@ -142,17 +155,28 @@ void setup() {
   ackReceived = false;
   esp_now_send(broadcastAddress, &data, 1);
   
+  TRACE_BEGIN(TP_HUB_PING);
   unsigned long start = millis();
   while (millis() - start < 500) { // Increased wait for Hub ACK
     if (ackReceived) break;
     delay(10);
   }
+  TRACE_END_RESULT(TP_HUB_PING, ackReceived);
 
 // ... existing Ping Hub logic ...
 
 if (ackReceived) {
     missCount = 0; // Reset misses on success
     Serial.println("\n>>> HUB ONLINE! Capturing...");
+#ifdef FARM_TRACE
+    // Ship phase records from previous cycles (including missed ones)
+    uint8_t traceFrame[FARM_TRACE_FRAME_BYTES(FARM_TRACE_SHIP_SPOKE)];
+    size_t traceLen = farmTraceExportFrame(2, traceFrame, sizeof(traceFrame));
+    if (traceLen > FARM_TRACE_FRAME_HDR) {
+      esp_now_send(broadcastAddress, traceFrame, traceLen);
+      delay(40);
+    }
+#endif
     runCameraSequence(); //
     delay(1000); 
     deepSleep(15); // SUCCESS: Wake up in 15 mins for the next photo